@@ -0,0 +1,102 @@
+/*
+  tzbench.cpp - measure parse time of TinyTZ TZ string parsers
+  Copyright (c) 2017 Timo Kokkonen <tjko@iki.fi>.
+
+  This file is part of TinyTZ Library.
+
+  TinyTZ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TinyTZ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  Host (Linux) tool that parses a set of TZ strings repeatedly with
+  each of the parsers and prints average time per parse.
+
+  Build (from top level directory of the library):
+
+    g++ -O2 -std=gnu++11 -Iextras/tzcompare -Isrc -o tzbench \
+        extras/tzbench/tzbench.cpp src/TinyTZ.cpp src/tzset.cpp \
+        src/tiny_parser.cpp src/dfa_parser.cpp src/tz_snapshot.cpp \
+        src/tz_bucket.cpp
+
+  Code size and stack usage of the parsers can be checked with the
+  same compiler flags as used for the target, for example:
+
+    g++ -Os -std=gnu++11 -Iextras/tzcompare -Isrc -fstack-usage -c \
+        src/tiny_parser.cpp src/dfa_parser.cpp src/tzset.cpp
+    nm -S --size-sort -C tiny_parser.o dfa_parser.o tzset.o
+    cat tiny_parser.su dfa_parser.su tzset.su
+
+  (use avr-g++ / avr-nm with Arduino core include paths for AVR figures)
+
+  Usage: tzbench [count]
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include "TinyTZ.h"
+
+void __tzset_parse_tz (const char *tz, tz_rule *tz_rules);
+int __parse_TZ_string(const char *str, tz_rule *tz_rules);
+int __parse_TZ_dfa(const char *str, tz_rule *tz_rules);
+
+
+static const char *tz_strings[] = {
+  "EST5EDT,M3.2.0,M11.1.0",
+  "CET-1CEST,M3.5.0,M10.5.0/3",
+  "AEST-10AEDT,M10.1.0,M4.1.0/3",
+  "EST5EDT4,M3.2.0/2:00:00,M11.1.0/02:00",
+};
+
+#define TZ_STRINGS (sizeof(tz_strings) / sizeof(tz_strings[0]))
+
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const char *name, int (*parse)(const char *, tz_rule *),
+		  unsigned long count) {
+  tz_rule rules[2];
+  double t0 = now();
+
+  for (unsigned long i = 0; i < count; i++) {
+    parse(tz_strings[i % TZ_STRINGS], rules);
+    asm volatile("" : : "r"(rules) : "memory");
+  }
+
+  printf("%-12s %8.0f ns/parse\n", name, (now() - t0) * 1e9 / count);
+}
+
+static int parse_glibc(const char *str, tz_rule *rules) {
+  __tzset_parse_tz(str, rules);
+  return 0;
+}
+
+
+int main(int argc, char **argv) {
+  unsigned long count = (argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000);
+
+  if (count < 1) count = 1;
+
+  bench("parser 0", parse_glibc, count);
+  bench("parser 1", __parse_TZ_string, count);
+  bench("parser 2", __parse_TZ_dfa, count);
+
+  return 0;
+}
+
+
+/* eof :-) */
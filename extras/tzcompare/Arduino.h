@@ -0,0 +1,27 @@
+/*
+  Arduino.h - minimal host (Linux) replacement for building TinyTZ
+  sources outside of Arduino environment (for tzcompare).
+ */
+
+#ifndef TZCOMPARE_ARDUINO_H
+#define TZCOMPARE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+/* host time functions use Unix epoch (AVR time.h uses Y2K epoch)  */
+#define UNIX_OFFSET 0
+
+static inline void set_zone(long) { }
+static inline void set_dst(int (*)(const uint32_t *, int32_t *)) { }
+
+#endif
@@ -0,0 +1,443 @@
+/*
+  tzcompare.cpp - compare TinyTZ against GNU libc using system zoneinfo
+  Copyright (c) 2017 Timo Kokkonen <tjko@iki.fi>.
+
+  This file is part of TinyTZ Library.
+
+  TinyTZ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TinyTZ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  Host (Linux) tool that reads the POSIX TZ string (footer) of every
+  zone in zoneinfo directory, and compares isdst/offset from TinyTZ
+  (using each of the TZ string parsers, with and without precomputed
+  transition window) against localtime_r() from GNU libc using the same
+  TZ string. Times are sampled every 'step' seconds, and each change of
+  offset seen in GNU libc results is also checked to the exact second.
+  Local times around each change (including skipped and repeated ones)
+  are converted back with toUTC() and compared against the earliest
+  matching instant according to GNU libc.
+
+  Rules are checked even if the parser reports an error, since setTZ()
+  uses them anyway. Exit status is 2 if the default parser (TINY_PARSER)
+  or the table driven parser has any mismatches.
+
+  Build (from top level directory of the library):
+
+    g++ -O2 -std=gnu++11 -Iextras/tzcompare -Isrc -o tzcompare \
+        extras/tzcompare/tzcompare.cpp src/TinyTZ.cpp src/tzset.cpp \
+        src/tiny_parser.cpp src/dfa_parser.cpp src/tz_snapshot.cpp \
+        src/tz_bucket.cpp
+
+  Usage: tzcompare [-v] [-s step] [-f from_year] [-t to_year] [zoneinfo]
+ */
+
+#define _GNU_SOURCE 1
+#include <Arduino.h>
+#include <time.h>
+#include <unistd.h>
+#include <ftw.h>
+#include "TinyTZ.h"
+
+void __tzset_parse_tz (const char *tz, tz_rule *tz_rules);
+int __parse_TZ_string(const char *str, tz_rule *tz_rules);
+int __parse_TZ_dfa(const char *str, tz_rule *tz_rules);
+void __tzset_compute_window (tz_rule *rules, tz_window *window,
+			     int year, uint8_t years);
+
+
+enum { I_GLIBC, I_PARSER0, I_PARSER1, I_PARSER2,
+       I_WINDOW0, I_WINDOW1, I_WINDOW2, IMPL_COUNT };
+
+#define PARSERS 3
+
+static const char *impl_names[IMPL_COUNT] = {
+  "glibc localtime_r",
+  "TinyTZ (parser 0)",
+  "TinyTZ (parser 1)",
+  "TinyTZ (parser 2)",
+  "TinyTZ (parser 0, window)",
+  "TinyTZ (parser 1, window)",
+  "TinyTZ (parser 2, window)"
+};
+
+/* TinyTZ zone, and (in window mode) years covered by its window.  */
+typedef struct {
+  tz_zone zone;
+  byte window;
+  uint32_t window_start, window_end;
+} impl_zone;
+
+typedef struct {
+  unsigned long parse_errors;
+  unsigned long zones;          /* zones with mismatches  */
+  unsigned long mismatches;
+  unsigned long utc_mismatches; /* toUTC() round trip  */
+  unsigned long long conversions;
+  double seconds;
+} impl_stats;
+
+static impl_stats stats[IMPL_COUNT];
+static unsigned long zones, skipped;
+
+static int verbose = 0;
+static uint32_t step = 3607;
+static int from_year = 1970;
+static int to_year = 2037;
+static const char *zoneinfo = "/usr/share/zoneinfo";
+
+static uint32_t *samples;
+static int8_t *ref_isdst, *isdst;
+static int32_t *ref_offset, *offset;
+static size_t sample_count;
+
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t year_start(int year) {
+  struct tm tm;
+
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_year = year - 1900;
+  tm.tm_mday = 1;
+  return timegm(&tm);
+}
+
+
+/* Read POSIX TZ string from the end of TZif (version 2+) file.  */
+static int read_footer(const char *path, char *buf, size_t len) {
+  char head[5];
+  long size, pos;
+  FILE *fp;
+  int c, n = 0;
+
+  if (!(fp = fopen(path, "rb"))) return -1;
+  if (fread(head, 1, 5, fp) != 5 || memcmp(head, "TZif", 4) || head[4] < '2'
+      || fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 2) {
+    fclose(fp);
+    return -1;
+  }
+
+  // footer is between the last two newlines...
+  for (pos = size - 2; pos > 0; pos--) {
+    fseek(fp, pos, SEEK_SET);
+    if ((c = fgetc(fp)) == '\n') break;
+  }
+  if (pos <= 0 || size - pos - 2 >= (long)len) {
+    fclose(fp);
+    return -1;
+  }
+  while (pos + 1 + n < size - 1 && (c = fgetc(fp)) != EOF && c != '\n')
+    buf[n++] = c;
+  buf[n] = 0;
+  fclose(fp);
+
+  return n;
+}
+
+
+/* Sample GNU libc results (reference).  */
+static void run_glibc(const char *tz, int8_t *dst, int32_t *off) {
+  struct tm tm;
+  time_t t;
+
+  setenv("TZ", tz, 1);
+  tzset();
+  for (size_t i = 0; i < sample_count; i++) {
+    t = samples[i];
+    localtime_r(&t, &tm);
+    dst[i] = tm.tm_isdst;
+    off[i] = tm.tm_gmtoff;
+  }
+}
+
+/* Return DST flag at T, in window mode moving the window first to
+   cover the year of T if needed.  */
+static int impl_isdst(impl_zone *z, uint32_t t) {
+  if (z->window && (t < z->window_start || t >= z->window_end)) {
+    struct tm tm;
+    time_t tt = t;
+    int year;
+
+    gmtime_r(&tt, &tm);
+    year = 1900 + tm.tm_year;
+    __tzset_compute_window(z->zone.rules, &z->zone.window, year,
+			   TZ_WINDOW_SIZE / 2);
+    z->window_start = year_start(year);
+    z->window_end = year_start(year + TZ_WINDOW_SIZE / 2);
+  }
+
+  return TinyTimezone::isdst(&z->zone, t);
+}
+
+static void run_tinytz(impl_zone *z, int8_t *dst, int32_t *off) {
+  for (size_t i = 0; i < sample_count; i++) {
+    dst[i] = impl_isdst(z, samples[i]);
+    off[i] = z->zone.rules[dst[i]].offset;
+  }
+}
+
+static int glibc_offset(uint32_t t, int *dst) {
+  struct tm tm;
+  time_t tt = t;
+
+  localtime_r(&tt, &tm);
+  *dst = tm.tm_isdst;
+  return tm.tm_gmtoff;
+}
+
+static int check(const char *name, impl_zone *z, uint32_t t,
+		 int ref_dst, int32_t ref_off) {
+  int dst = impl_isdst(z, t);
+
+  if (dst == ref_dst && z->zone.rules[dst].offset == ref_off)
+    return 0;
+  if (verbose > 1)
+    printf("  %s: %u: isdst=%d offset=%ld (expected isdst=%d offset=%ld)\n",
+	   name, t, dst, (long)z->zone.rules[dst].offset, ref_dst, (long)ref_off);
+  return 1;
+}
+
+/* Return UTC time for local time LOCAL next to a change between offsets
+   OFF_A and OFF_B, according to GNU libc: the earliest instant that
+   localtime_r() shows as LOCAL, or standard time (STD_OFF) if LOCAL
+   was skipped.  */
+static uint32_t glibc_to_utc(uint32_t local, int32_t off_a, int32_t off_b,
+			     int32_t std_off) {
+  uint32_t ta = local - off_a, tb = local - off_b;
+  int dst, a, b;
+
+  a = (glibc_offset(ta, &dst) == off_a);
+  b = (glibc_offset(tb, &dst) == off_b);
+  if (a && b)
+    return (ta < tb ? ta : tb);
+  if (a)
+    return ta;
+  if (b)
+    return tb;
+  return local - std_off;
+}
+
+static int check_utc(const char *name, impl_zone *z, uint32_t local,
+		     uint32_t ref) {
+  uint32_t t = TinyTimezone::toUTC(&z->zone, local);
+
+  if (t == ref)
+    return 0;
+  if (verbose > 1)
+    printf("  %s: toUTC(%u) = %u (expected %u)\n", name, local, t, ref);
+  return 1;
+}
+
+
+static void compare_zone(const char *name, const char *tz) {
+  impl_zone zones_[IMPL_COUNT];
+  unsigned long bad[IMPL_COUNT], bad_utc[IMPL_COUNT];
+  double t0;
+  int rc;
+
+  memset(zones_, 0, sizeof(zones_));
+  memset(bad, 0, sizeof(bad));
+  memset(bad_utc, 0, sizeof(bad_utc));
+
+  t0 = now();
+  run_glibc(tz, ref_isdst, ref_offset);
+  stats[I_GLIBC].seconds += now() - t0;
+  stats[I_GLIBC].conversions += sample_count;
+
+  for (int i = I_PARSER0; i < IMPL_COUNT; i++) {
+    impl_zone *z = &zones_[i];
+
+    switch ((i - I_PARSER0) % PARSERS) {
+    case 0:
+      __tzset_parse_tz(tz, z->zone.rules);
+      rc = (z->zone.rules[0].name[0] ? 0 : -1);
+      break;
+    case 1:
+      rc = __parse_TZ_string(tz, z->zone.rules);
+      break;
+    default:
+      rc = __parse_TZ_dfa(tz, z->zone.rules);
+      break;
+    }
+    // check the rules anyway, setTZ() ignores parse errors...
+    if (rc < 0) {
+      stats[i].parse_errors++;
+      if (verbose)
+	printf("%s: %s: parse error (%d): %s\n", name, impl_names[i], rc, tz);
+    }
+    z->window = (i >= I_WINDOW0);
+
+    t0 = now();
+    run_tinytz(z, isdst, offset);
+    stats[i].seconds += now() - t0;
+    stats[i].conversions += sample_count;
+
+    for (size_t j = 0; j < sample_count; j++) {
+      if (isdst[j] != ref_isdst[j] || offset[j] != ref_offset[j]) {
+	bad[i]++;
+	if (verbose > 1)
+	  printf("  %s: %u: isdst=%d offset=%ld (expected isdst=%d offset=%ld)\n",
+		 impl_names[i], samples[j], isdst[j], (long)offset[j],
+		 ref_isdst[j], (long)ref_offset[j]);
+      }
+    }
+  }
+
+  // find exact times of change (in GNU libc) and check both sides...
+  for (size_t j = 1; j < sample_count; j++) {
+    uint32_t lo = samples[j - 1], hi = samples[j], mid;
+    int dst, lo_dst = ref_isdst[j - 1];
+    int32_t lo_off = ref_offset[j - 1];
+
+    if (ref_offset[j] == lo_off && ref_isdst[j] == lo_dst)
+      continue;
+    while (hi - lo > 1) {
+      mid = lo + (hi - lo) / 2;
+      if (glibc_offset(mid, &dst) == lo_off && dst == lo_dst)
+	lo = mid;
+      else
+	hi = mid;
+    }
+    for (int i = I_PARSER0; i < IMPL_COUNT; i++) {
+      bad[i] += check(impl_names[i], &zones_[i], lo, lo_dst, lo_off);
+      bad[i] += check(impl_names[i], &zones_[i], hi, ref_isdst[j],
+		      ref_offset[j]);
+    }
+
+    // local times at both edges and middle of the skipped/repeated range...
+    int32_t hi_off = ref_offset[j];
+    int32_t std_off = (lo_dst ? hi_off : lo_off);
+    uint32_t local[7] = {
+      hi + lo_off - 1, hi + lo_off, hi + lo_off + 1,
+      hi + hi_off - 1, hi + hi_off, hi + hi_off + 1,
+      hi + (lo_off + hi_off) / 2
+    };
+    for (byte k = 0; k < 7; k++) {
+      uint32_t ref = glibc_to_utc(local[k], lo_off, hi_off, std_off);
+
+      for (int i = I_PARSER0; i < IMPL_COUNT; i++)
+	bad_utc[i] += check_utc(impl_names[i], &zones_[i], local[k], ref);
+    }
+  }
+
+  for (int i = I_PARSER0; i < IMPL_COUNT; i++) {
+    if (bad[i] || bad_utc[i]) {
+      stats[i].zones++;
+      stats[i].mismatches += bad[i];
+      stats[i].utc_mismatches += bad_utc[i];
+      if (verbose)
+	printf("%s: %s: %lu mismatches, %lu toUTC mismatches: %s\n", name,
+	       impl_names[i], bad[i], bad_utc[i], tz);
+    }
+  }
+}
+
+
+static int walk(const char *path, const struct stat *st, int type,
+		struct FTW *ftw) {
+  const char *name = path + strlen(zoneinfo) + 1;
+  char tz[128];
+
+  (void)st;
+
+  if (type == FTW_D && ftw->level == 1
+      && (!strcmp(name, "posix") || !strcmp(name, "right")))
+    return FTW_SKIP_SUBTREE;
+  if (type != FTW_F)
+    return FTW_CONTINUE;
+
+  if (read_footer(path, tz, sizeof(tz)) <= 0) {
+    skipped++;
+    return FTW_CONTINUE;
+  }
+
+  zones++;
+  compare_zone(name, tz);
+
+  return FTW_CONTINUE;
+}
+
+
+int main(int argc, char **argv) {
+  uint32_t start, end;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vs:f:t:")) != -1) {
+    switch (opt) {
+    case 'v': verbose++; break;
+    case 's': step = strtoul(optarg, NULL, 10); break;
+    case 'f': from_year = atoi(optarg); break;
+    case 't': to_year = atoi(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-v] [-s step] [-f from_year] "
+	      "[-t to_year] [zoneinfo]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (optind < argc)
+    zoneinfo = argv[optind];
+  if (step < 1 || from_year < 1970 || to_year < from_year || to_year > 2105) {
+    fprintf(stderr, "%s: invalid arguments\n", argv[0]);
+    return 1;
+  }
+
+  start = year_start(from_year);
+  end = year_start(to_year + 1) - 1;
+  sample_count = (end - start) / step + 1;
+
+  samples = (uint32_t *)malloc(sample_count * sizeof(uint32_t));
+  ref_isdst = (int8_t *)malloc(sample_count);
+  isdst = (int8_t *)malloc(sample_count);
+  ref_offset = (int32_t *)malloc(sample_count * sizeof(int32_t));
+  offset = (int32_t *)malloc(sample_count * sizeof(int32_t));
+  if (!samples || !ref_isdst || !isdst || !ref_offset || !offset) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+  for (size_t i = 0; i < sample_count; i++)
+    samples[i] = start + i * step;
+
+  if (nftw(zoneinfo, walk, 16, FTW_PHYS | FTW_ACTIONRETVAL) < 0) {
+    perror(zoneinfo);
+    return 1;
+  }
+
+  printf("%lu zones (%lu files skipped), %d-%d, %lu samples/zone (step %us)\n\n",
+	 zones, skipped, from_year, to_year, (unsigned long)sample_count, step);
+  printf("%-26s %8s %8s %12s %8s %14s\n", "implementation", "parse", "zones",
+	 "mismatches", "toUTC", "conversions/s");
+  for (int i = 0; i < IMPL_COUNT; i++) {
+    printf("%-26s %8lu %8lu %12lu %8lu %14.0f\n", impl_names[i],
+	   stats[i].parse_errors, stats[i].zones, stats[i].mismatches,
+	   stats[i].utc_mismatches,
+	   stats[i].seconds > 0 ? stats[i].conversions / stats[i].seconds : 0);
+  }
+
+  for (int i = I_PARSER0; i < IMPL_COUNT; i++) {
+    int parser = (i - I_PARSER0) % PARSERS;
+
+    if ((parser == TINY_PARSER || parser == 2)
+	&& (stats[i].mismatches || stats[i].utc_mismatches))
+      return 2;
+  }
+  return 0;
+}
+
+
+/* eof :-) */
@@ -27,30 +27,42 @@
 
 
 void __tzset_compute_change (tz_rule *rule, int year);
-
-#if TINY_PARSER
-int __parse_TZ_string(const char *str);
-# define tinytz_parse_tz(x)  __parse_TZ_string(x) 
+void __tzset_compute_window (tz_rule *rules, tz_window *window,
+			     int year, uint8_t years);
+int __tzset_window_isdst (const tz_window *window, uint32_t t);
+int __tz_snapshot_write (tz_snapshot *snap, const tz_rule *rules,
+			 const tz_window *window);
+int __tz_snapshot_read (const tz_snapshot *snap, tz_rule *rules,
+			tz_window *window);
+
+#if TINY_PARSER == 2
+int __parse_TZ_dfa(const char *str, tz_rule *tz_rules);
+# define tinytz_parse_tz(x, r)  __parse_TZ_dfa(x, r)
+#elif TINY_PARSER
+int __parse_TZ_string(const char *str, tz_rule *tz_rules);
+# define tinytz_parse_tz(x, r)  __parse_TZ_string(x, r) 
 #else
-void __tzset_parse_tz (const char *tz);
-# define tinytz_parse_tz(x)  __tzset_parse_tz(x)
+void __tzset_parse_tz (const char *tz, tz_rule *tz_rules);
+# define tinytz_parse_tz(x, r)  __tzset_parse_tz(x, r)
 #endif
 
 
 TinyTimezone TinyTZ;
 
 tz_rule TinyTimezone::tz_rules[2];
+tz_window TinyTimezone::window;
 
 
 TinyTimezone::TinyTimezone() {
   char tmp[4] = { 'U','T','C',0 };;
-  tinytz_parse_tz(tmp);
+  tinytz_parse_tz(tmp, tz_rules);
   set_dst(avr_dst);
   set_zone(0);
 }
 
 void TinyTimezone::setTZ(const char *tz) {
-  tinytz_parse_tz(tz);
+  tinytz_parse_tz(tz, tz_rules);
+  window.count = 0;
   set_zone(tz_rules[0].offset);
 #if 0
   Serial.print(F("TinyTZ.setTZ: "));
@@ -78,29 +90,118 @@ void TinyTimezone::setTZ(const char *tz) {
 #endif
 }
 
-int TinyTimezone::isdst(uint32_t timer) {
+/* Precompute times of change for 'years' years starting from 'year'
+   and store current timezone into snapshot 'snap'.  */
+int TinyTimezone::saveTZ(tz_snapshot *snap, int year, uint8_t years) {
+  __tzset_compute_window(tz_rules, &window, year, years);
+  return __tz_snapshot_write(snap, tz_rules, &window);
+}
+
+/* Restore timezone from snapshot 'snap' (in RAM). Returns negative
+   value if snapshot is not valid, in which case current timezone
+   is left untouched.  */
+int TinyTimezone::loadTZ(const tz_snapshot *snap) {
+  int r = __tz_snapshot_read(snap, tz_rules, &window);
+
+  if (r == 0)
+    set_zone(tz_rules[0].offset);
+  return r;
+}
+
+/* Return DST flag in effect at 'timer' (Unix time) for timezone
+   described by 'rules' and 'window'.  */
+int __tz_isdst(tz_rule *rules, const tz_window *window, uint32_t timer) {
   struct tm t;
   time_t atime = timer - UNIX_OFFSET;;
   int isdst;
 
-  if (tz_rules[0].offset == tz_rules[1].offset)
+  if (!tz_has_dst(rules))
     return 0;
 
+  if ((isdst = __tzset_window_isdst(window, timer)) >= 0)
+    return isdst;
+
   gmtime_r(&atime, &t);
-  __tzset_compute_change(&tz_rules[0], 1900 + t.tm_year);
-  __tzset_compute_change(&tz_rules[1], 1900 + t.tm_year);
+  __tzset_compute_change(&rules[0], 1900 + t.tm_year);
+  __tzset_compute_change(&rules[1], 1900 + t.tm_year);
 
     /* We have to distinguish between northern and southern
       hemisphere.  For the latter the daylight saving time
       ends in the next year.  */
-  if (__builtin_expect (tz_rules[0].change > tz_rules[1].change, 0))
-    isdst = (timer < tz_rules[1].change || timer >= tz_rules[0].change);
+  if (__builtin_expect (rules[0].change > rules[1].change, 0))
+    isdst = (timer < rules[1].change || timer >= rules[0].change);
   else
-    isdst = (timer >= tz_rules[0].change && timer < tz_rules[1].change);
+    isdst = (timer >= rules[0].change && timer < rules[1].change);
 
   return isdst;
 }
 
+int TinyTimezone::isdst(uint32_t timer) {
+  return __tz_isdst(tz_rules, &window, timer);
+}
+
+
+/* Zone handles: same as above but for timezone in 'zone' instead
+   of the global timezone (tz_rules), which is never touched.  */
+
+void TinyTimezone::setZone(tz_zone *zone, const char *tz, int year, uint8_t years) {
+  tinytz_parse_tz(tz, zone->rules);
+  zone->window.count = 0;
+  if (year >= 0)
+    __tzset_compute_window(zone->rules, &zone->window, year, years);
+}
+
+void TinyTimezone::getZone(tz_zone *zone) {
+  memcpy(zone->rules, tz_rules, sizeof(zone->rules));
+  memcpy(&zone->window, &window, sizeof(zone->window));
+}
+
+int TinyTimezone::loadZone(tz_zone *zone, const tz_snapshot *snap) {
+  return __tz_snapshot_read(snap, zone->rules, &zone->window);
+}
+
+int TinyTimezone::isdst(tz_zone *zone, uint32_t timer) {
+  return __tz_isdst(zone->rules, &zone->window, timer);
+}
+
+long TinyTimezone::offset(tz_zone *zone, uint32_t timer) {
+  return zone->rules[(isdst(zone, timer) ? 1 : 0)].offset;
+}
+
+/* Convert local time 'local' (seconds since 1970-01-01 00:00 local time)
+   in zone 'from' to UTC.  Ambiguous local times (when clocks are turned
+   back) map to the earlier instant, and non-existent local times
+   (when clocks are turned forward) are interpreted as standard time.  */
+uint32_t TinyTimezone::toUTC(tz_zone *from, uint32_t local) {
+  uint32_t t0 = local - from->rules[0].offset;
+  uint32_t t1;
+
+  if (!tz_has_dst(from->rules))
+    return t0;
+
+  // candidate instants for standard and daylight time...
+  t1 = local - from->rules[1].offset;
+  if (isdst(from, t1)) {
+    if (!isdst(from, t0) && t0 < t1)
+      return t0;
+    return t1;
+  }
+  return t0;
+}
+
+/* Convert local time in zone 'from' to local time in zone 'to'.  */
+uint32_t TinyTimezone::convert(tz_zone *from, tz_zone *to, uint32_t local) {
+  uint32_t t = toUTC(from, local);
+
+  return t + offset(to, t);
+}
+
+void TinyTimezone::convert(tz_zone *from, tz_zone *to, const uint32_t *in,
+			   uint32_t *out, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    out[i] = convert(from, to, in[i]);
+}
+
 
 int TinyTimezone::avr_dst(const uint32_t * timer, int32_t * z) {
   int dst = isdst(*timer + *z + UNIX_OFFSET);
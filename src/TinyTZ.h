@@ -30,9 +30,13 @@
 /* Set TINY_PARSER to select POSIX TZ string parser:
      0 = GNU C Library parser
      1 = TinyTZ parser
+     2 = TinyTZ table driven (state machine) parser
   
   TinyTZ parser is some 2.5kB smaller (flash usage) and uses some 
   40 bytes less SRAM, but might not be as robust as the GNU libc one.
+
+  Table driven parser scans the TZ string only once and accepts the
+  full POSIX syntax (including quoted names and J/n/M rules).
 */     
 #define TINY_PARSER 1
 
@@ -61,16 +65,73 @@ typedef struct {
   int16_t computed_for;    /* Year above is computed for.  */
 } tz_rule;
 
+/* Nonzero if RULES (standard, daylight) describe a timezone with DST.  */
+#define tz_has_dst(rules) \
+  ((rules)[1].name[0] && (rules)[0].offset != (rules)[1].offset)
+
+
+/* Number of precomputed times of change kept in a transition
+   window (two per year).  */
+#define TZ_WINDOW_SIZE 8
+
+/* Precomputed times of change for a range of years, so that DST
+   lookups within the window need no calendar math.  */
+
+typedef struct {
+  uint32_t change[TZ_WINDOW_SIZE];  /* Sorted times of change (Unix time).  */
+  uint8_t count;                    /* Number of valid entries.  */
+  uint8_t isdst;                    /* DST flag in effect from change[0].  */
+} tz_window;
+
+typedef struct {
+  tz_rule rules[2];
+  tz_window window;
+} tz_zone;
+
+
+/* Range of time [start, end) during which UTC offset of a timezone
+   stays constant.  */
+
+typedef struct {
+  uint32_t start;             /* Start of the segment (Unix time).  */
+  uint32_t end;               /* End of the segment (exclusive).  */
+  int32_t offset;             /* Seconds east of GMT during the segment.  */
+  uint8_t isdst;
+} tz_segment;
+
+
+/* Binary snapshot of a timezone (parsed rules and transition window)
+   that can be stored in EEPROM, flash or a file and restored with
+   loadTZ() without parsing the TZ string again.
+
+   Snapshot uses the native structure layout, so it is only valid
+   on the same architecture (and TinyTZ version) that created it.  */
+
+#define TZ_SNAPSHOT_MAGIC   0x5A54
+#define TZ_SNAPSHOT_VERSION 1
+
+typedef struct {
+  uint16_t magic;
+  uint16_t size;              /* sizeof(tz_snapshot)  */
+  uint8_t version;
+  tz_zone zone;
+  uint16_t crc;               /* CRC-16/CCITT of the preceding bytes.  */
+} tz_snapshot;
+
+
 //extern tz_rule tz_rules[2];
 
 class TinyTimezone
 {
  public:
   static tz_rule tz_rules[2];
+  static tz_window window;
 
   TinyTimezone();
   
   static void setTZ(const char *tz = NULL);
+  static int saveTZ(tz_snapshot *snap, int year, uint8_t years = TZ_WINDOW_SIZE / 2);
+  static int loadTZ(const tz_snapshot *snap);
   static int avr_dst(const uint32_t * timer, int32_t * z);
   const char* timezone(int isdst = 0) {
     return tz_rules[(isdst ? 1 : 0)].name;
@@ -80,6 +141,28 @@ class TinyTimezone
   }
   static int isdst(uint32_t time);
 
+  /* Zone handles (independent of the global timezone).  */
+  static void setZone(tz_zone *zone, const char *tz, int year = -1,
+		      uint8_t years = TZ_WINDOW_SIZE / 2);
+  static void getZone(tz_zone *zone);
+  static int loadZone(tz_zone *zone, const tz_snapshot *snap);
+  static int isdst(tz_zone *zone, uint32_t time);
+  static long offset(tz_zone *zone, uint32_t time);
+  static uint32_t toUTC(tz_zone *from, uint32_t local);
+  static uint32_t convert(tz_zone *from, tz_zone *to, uint32_t local);
+  static void convert(tz_zone *from, tz_zone *to, const uint32_t *in,
+		      uint32_t *out, size_t count);
+
+  /* Local time bucketing (day/hour indices since 1970-01-01 local time).  */
+  static uint32_t localDay(tz_zone *zone, uint32_t time);
+  static uint32_t localHour(tz_zone *zone, uint32_t time);
+  static void localDays(tz_zone *zone, const uint32_t *time, uint32_t *days,
+			size_t count);
+  static void localHours(tz_zone *zone, const uint32_t *time, uint32_t *hours,
+			 size_t count);
+  static int segment(tz_zone *zone, uint32_t start, uint32_t end,
+		     tz_segment *seg);
+
 
 };
 
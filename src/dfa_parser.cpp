@@ -0,0 +1,227 @@
+/*
+  dfa_parser.cpp - table driven (state machine) TZ string parser
+  Copyright (c) 2017 Timo Kokkonen <tjko@iki.fi>.
+
+  This file is part of TinyTZ Library.
+
+  TinyTZ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TinyTZ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include "TinyTZ.h"
+
+/*
+  TZ string is scanned once, one character at a time. Each character
+  is mapped into a character class and the transition table gives the
+  next (lexical) state. Transitions marked with COMMIT end the current
+  field, which is then stored into tz_rules. Position in the grammar
+
+    std offset [dst [offset] [,start[/time],end[/time]]]
+
+  is tracked with field counter (F_*), so the same states can be used
+  for all offsets, times and dates.
+*/
+
+// character classes
+enum { C_END, C_ALPHA, C_DIGIT, C_SIGN, C_COLON, C_DOT, C_COMMA, C_SLASH,
+       C_LT, C_GT, C_J, C_M, C_OTHER, C_COUNT };
+
+// states
+enum { S_ERR, S_NAME0, S_NAME, S_QNAME, S_QEND, S_SIGN, S_NUM, S_SEP,
+       S_DATE, S_J, S_M, S_TIME, S_DONE, S_COUNT };
+
+// fields
+enum { F_STD_NAME, F_STD_OFFSET, F_DST_NAME, F_DST_OFFSET,
+       F_START, F_START_TIME, F_END, F_END_TIME, F_COUNT };
+
+#define COMMIT 0x80
+
+#define _E  S_ERR
+#define _C(s) (COMMIT | (s))
+
+static const byte dfa_table[S_COUNT][C_COUNT] PROGMEM = {
+  /*            END        ALPHA       DIGIT      SIGN       COLON  DOT    COMMA        SLASH        LT           GT       J           M           OTHER */
+  /* ERR   */ { _E,        _E,         _E,        _E,        _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+  /* NAME0 */ { _E,        S_NAME,     _E,        _E,        _E,    _E,    _E,          _E,          S_QNAME,     _E,      S_NAME,     S_NAME,     _E },
+  /* NAME  */ { _C(S_DONE),S_NAME,     _C(S_NUM), _C(S_SIGN),_E,    _E,    _C(S_DATE),  _E,          _E,          _E,      S_NAME,     S_NAME,     _E },
+  /* QNAME */ { _E,        S_QNAME,    S_QNAME,   S_QNAME,   _E,    _E,    _E,          _E,          _E,          S_QEND,  S_QNAME,    S_QNAME,    _E },
+  /* QEND  */ { _C(S_DONE),_E,         _C(S_NUM), _C(S_SIGN),_E,    _E,    _C(S_DATE),  _E,          _E,          _E,      _E,         _E,         _E },
+  /* SIGN  */ { _E,        _E,         S_NUM,     _E,        _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+  /* NUM   */ { _C(S_DONE),_C(S_NAME), S_NUM,     _E,        S_SEP, S_SEP, _C(S_DATE),  _C(S_TIME),  _C(S_QNAME), _E,      _C(S_NAME), _C(S_NAME), _E },
+  /* SEP   */ { _E,        _E,         S_NUM,     _E,        _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+  /* DATE  */ { _E,        _E,         S_NUM,     _E,        _E,    _E,    _E,          _E,          _E,          _E,      S_J,        S_M,        _E },
+  /* J     */ { _E,        _E,         S_NUM,     _E,        _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+  /* M     */ { _E,        _E,         S_NUM,     _E,        _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+  /* TIME  */ { _E,        _E,         S_NUM,     S_SIGN,    _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+  /* DONE  */ { _E,        _E,         _E,        _E,        _E,    _E,    _E,          _E,          _E,          _E,      _E,         _E,         _E },
+};
+
+/* Fields that may be followed by a character of given class
+   (bit N set = field N may end with this class).  */
+#define FB(f) (1 << (f))
+#define FOLLOW_END   (FB(F_STD_NAME) | FB(F_STD_OFFSET) | FB(F_DST_NAME) | FB(F_DST_OFFSET) | FB(F_END) | FB(F_END_TIME))
+#define FOLLOW_NAME  (FB(F_STD_OFFSET))
+#define FOLLOW_COMMA (FB(F_DST_NAME) | FB(F_DST_OFFSET) | FB(F_START) | FB(F_START_TIME))
+#define FOLLOW_SLASH (FB(F_START) | FB(F_END))
+#define FOLLOW_NUM   (FB(F_STD_NAME) | FB(F_DST_NAME))
+
+
+static byte dfa_class(char c) {
+  if (c == 'J') return C_J;
+  if (c == 'M') return C_M;
+  if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) return C_ALPHA;
+  if (c >= '0' && c <= '9') return C_DIGIT;
+  switch (c) {
+  case 0: return C_END;
+  case '+':
+  case '-': return C_SIGN;
+  case ':': return C_COLON;
+  case '.': return C_DOT;
+  case ',': return C_COMMA;
+  case '/': return C_SLASH;
+  case '<': return C_LT;
+  case '>': return C_GT;
+  }
+  return C_OTHER;
+}
+
+
+int __parse_TZ_dfa(const char *str, tz_rule *tz_rules) {
+  byte state = S_NAME0;
+  byte field = F_STD_NAME;
+  byte cls, e, k = 0, neg = 0, len = 0;
+  uint16_t v[3] = { 0, 0, 0 };
+  tz_rule *r;
+  int32_t secs;
+  char c;
+
+  // reset tz structure to unnamed "UTC"...
+  memset(tz_rules, 0, 2 * sizeof(tz_rule));
+
+  do {
+    c = *str++;
+    cls = dfa_class(c);
+    e = pgm_read_byte(&dfa_table[state][cls]);
+    state = e & ~COMMIT;
+    if (state == S_ERR) goto fail;
+
+    if (e & COMMIT) {
+      // end of current field: check it can be followed by 'c'...
+      uint16_t follow = (cls == C_END ? FOLLOW_END :
+			 cls == C_COMMA ? FOLLOW_COMMA :
+			 cls == C_SLASH ? FOLLOW_SLASH :
+			 (cls == C_DIGIT || cls == C_SIGN) ? FOLLOW_NUM :
+			 FOLLOW_NAME);
+      if (!(follow & FB(field))) goto fail;
+
+      r = &tz_rules[field < F_START ? field / 2 : (field - F_START) / 2];
+      secs = (int32_t)v[0] * 3600 + (int32_t)v[1] * 60 + v[2];
+
+      switch (field) {
+      case F_STD_NAME:
+      case F_DST_NAME:
+	if (len < 3) goto fail;
+	// default to one hour later than standard time...
+	if (field == F_DST_NAME) r->offset = tz_rules[0].offset + 3600;
+	break;
+      case F_STD_OFFSET:
+      case F_DST_OFFSET:
+	if (k > 2 || v[0] > 24 || v[1] > 59 || v[2] > 59) goto fail;
+	r->offset = (neg ? secs : -secs);
+	break;
+      case F_START:
+      case F_END:
+	if (r->type == M) {
+	  if (k != 2 || v[0] < 1 || v[0] > 12 || v[1] < 1 || v[1] > 5
+	      || v[2] > 6) goto fail;
+	  r->m = v[0];
+	  r->n = v[1];
+	  r->d = v[2];
+	} else {
+	  if (k != 0 || v[0] > 365 || (r->type == J1 && v[0] == 0)) goto fail;
+	  r->d = v[0];
+	}
+	r->secs = 7200;
+	break;
+      case F_START_TIME:
+      case F_END_TIME:
+	if (k > 2 || v[0] > 167 || v[1] > 59 || v[2] > 59) goto fail;
+	r->secs = (neg ? -secs : secs);
+	break;
+      }
+
+      // move to next field...
+      if (cls == C_COMMA)
+	field = (field < F_START ? F_START : F_END);
+      else
+	field++;
+      k = neg = len = 0;
+      v[0] = v[1] = v[2] = 0;
+    }
+
+    // per character actions...
+    switch (state) {
+    case S_NAME:
+    case S_QNAME:
+      if (cls == C_LT) break;
+      r = &tz_rules[field / 2];
+      if (len < TZ_NAME_MAX_LEN) r->name[len] = c;
+      len++;
+      break;
+    case S_SIGN:
+      neg = (c == '-');
+      break;
+    case S_NUM:
+      if (cls != C_DIGIT) break;
+      if (v[k] > 999) goto fail;
+      v[k] = v[k] * 10 + (c - '0');
+      break;
+    case S_SEP:
+      // ':' only in offsets/times, '.' only in Mm.n.d dates...
+      if (++k > 2) goto fail;
+      if ((cls == C_DOT) != ((field == F_START || field == F_END)
+			     && tz_rules[(field - F_START) / 2].type == M))
+	goto fail;
+      break;
+    case S_J:
+    case S_M:
+      tz_rules[(field - F_START) / 2].type = (state == S_J ? J1 : M);
+      break;
+    }
+  } while (cls != C_END);
+
+  if (field <= F_DST_NAME) {
+    // there is no DST (no offset means UTC, like GNU libc)...
+    memcpy(tz_rules[1].name, tz_rules[0].name, sizeof(tz_rules[1].name));
+    tz_rules[1].offset = tz_rules[0].offset;
+  } else if (field <= F_START) {
+    // no rules, default to "M3.2.0,M11.1.0" (same as GNU libc)
+    tz_rules[0].type = tz_rules[1].type = M;
+    tz_rules[0].m = 3;
+    tz_rules[0].n = 2;
+    tz_rules[1].m = 11;
+    tz_rules[1].n = 1;
+    tz_rules[0].secs = tz_rules[1].secs = 7200;
+  }
+  tz_rules[0].computed_for = tz_rules[1].computed_for = -1;
+
+  return 0;
+
+ fail:
+  memset(tz_rules, 0, 2 * sizeof(tz_rule));
+  return -1;
+}
+
+
+/* eof :-) */
@@ -25,8 +25,6 @@
 #define min(a, b)    ((a) < (b) ? (a) : (b))
 #define max(a, b)    ((a) > (b) ? (a) : (b))
 
-#define tz_rules TinyTimezone::tz_rules
-
 
 long __parse_TZ_offset(char *str, int *hours, int *mins, int *secs) {
   const char separator[] = ":";
@@ -58,7 +56,7 @@ long __parse_TZ_offset(char *str, int *hours, int *mins, int *secs) {
 }
 
 
-int __parse_TZ_string(const char *str) {
+int __parse_TZ_string(const char *str, tz_rule *tz_rules) {
     const char separator1[] = ",";
     const char separator2[] = "/";
     const char separator3[] = ".";
@@ -73,7 +71,7 @@ int __parse_TZ_string(const char *str) {
 
 
     // reset tz structure to unnamed "UTC"...
-    memset(tz_rules, 0, sizeof(tz_rules));
+    memset(tz_rules, 0, 2 * sizeof(tz_rule));
 
     memcpy(buf, str, l);
     buf[l]=0;
@@ -109,7 +107,13 @@ int __parse_TZ_string(const char *str) {
     l -= e-s;
     s=e;
     while ((e < s+l) && (*e != '+' && *e != '-' && ! (*e >= '0' && *e <= '9'))) e++;
-    if (e == s || e-s < 3) return -6;
+    if (e == s) {
+      // no DST, use standard time for both rules...
+      memcpy(tz_rules[1].name, tz_rules[0].name, sizeof(tz_rules[1].name));
+      tz_rules[1].offset = tz_rules[0].offset;
+      return 0;
+    }
+    if (e-s < 3) return -6;
     n = min(e - s, TZ_NAME_MAX_LEN);
     memcpy(tz_rules[1].name, s, n);
     tz_rules[1].name[n]=0;
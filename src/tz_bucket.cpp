@@ -0,0 +1,132 @@
+/*
+  tz_bucket.cpp - DST aware local time bucketing
+  Copyright (c) 2017 Timo Kokkonen <tjko@iki.fi>. 
+
+  This file is part of TinyTZ Library.
+
+  TinyTZ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TinyTZ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include "TinyTZ.h"
+
+#define SECSPERHOUR 3600L
+#define SECSPERDAY  86400L
+#define TIME_MAX    0xffffffffUL
+
+
+void __tzset_compute_change (tz_rule *rule, int year);
+uint32_t __tzset_window_next (const tz_window *window, uint32_t t);
+
+
+/* Return time of the first change after 'timer' (Unix time), or
+   TIME_MAX if the timezone has no DST.  */
+static uint32_t __tz_next_change(tz_rule *rules, const tz_window *window,
+				 uint32_t timer) {
+  struct tm t;
+  time_t atime = timer - UNIX_OFFSET;
+  uint32_t next;
+  int year;
+
+  if (!tz_has_dst(rules))
+    return TIME_MAX;
+
+  if ((next = __tzset_window_next(window, timer)))
+    return next;
+
+  gmtime_r(&atime, &t);
+  year = 1900 + t.tm_year;
+
+  // check changes in this year first, then in the next year...
+  next = TIME_MAX;
+  for (byte y = 0; y < 2 && next == TIME_MAX; y++) {
+    for (byte i = 0; i < 2; i++) {
+      __tzset_compute_change(&rules[i], year + y);
+      if (rules[i].change > timer && rules[i].change < next)
+	next = rules[i].change;
+    }
+  }
+
+  return next;
+}
+
+
+/* Return segment of constant UTC offset starting at 'start' and ending
+   at the next change or 'end' (whichever comes first). Returns 0 if
+   'start' is not before 'end'.
+
+   Typical use to split range [a, b) into segments:
+
+     for (t = a; TinyTZ.segment(&zone, t, b, &seg); t = seg.end) ...
+*/
+int TinyTimezone::segment(tz_zone *zone, uint32_t start, uint32_t end,
+			  tz_segment *seg) {
+  uint32_t next;
+
+  if (start >= end)
+    return 0;
+
+  seg->isdst = isdst(zone, start);
+  seg->offset = zone->rules[seg->isdst].offset;
+  next = __tz_next_change(zone->rules, &zone->window, start);
+  seg->start = start;
+  seg->end = (next < end ? next : end);
+
+  return 1;
+}
+
+
+uint32_t TinyTimezone::localDay(tz_zone *zone, uint32_t time) {
+  return (time + offset(zone, time)) / SECSPERDAY;
+}
+
+uint32_t TinyTimezone::localHour(tz_zone *zone, uint32_t time) {
+  return (time + offset(zone, time)) / SECSPERHOUR;
+}
+
+
+/* Map array of times into local buckets of 'size' seconds. Offset is
+   only looked up when a time falls outside of the current segment,
+   so (mostly) sorted input needs no DST lookups per time.  */
+static void __tz_buckets(tz_zone *zone, const uint32_t *time, uint32_t *out,
+			 size_t count, uint32_t size) {
+  tz_segment seg;
+
+  seg.start = seg.end = 0;
+  seg.offset = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t t = time[i];
+
+    if (t < seg.start || t >= seg.end) {
+      if (!TinyTimezone::segment(zone, t, TIME_MAX, &seg))
+	seg.offset = TinyTimezone::offset(zone, t);
+    }
+    out[i] = (t + seg.offset) / size;
+  }
+}
+
+void TinyTimezone::localDays(tz_zone *zone, const uint32_t *time,
+			     uint32_t *days, size_t count) {
+  __tz_buckets(zone, time, days, count, SECSPERDAY);
+}
+
+void TinyTimezone::localHours(tz_zone *zone, const uint32_t *time,
+			      uint32_t *hours, size_t count) {
+  __tz_buckets(zone, time, hours, count, SECSPERHOUR);
+}
+
+
+/* eof :-) */
@@ -0,0 +1,73 @@
+/*
+  tz_snapshot.cpp - binary snapshots of parsed timezone rules
+  Copyright (c) 2017 Timo Kokkonen <tjko@iki.fi>. 
+
+  This file is part of TinyTZ Library.
+
+  TinyTZ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TinyTZ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "TinyTZ.h"
+
+
+// CRC-16/CCITT (polynomial 0x1021, initial value 0xffff)
+static uint16_t __tz_snapshot_crc(const uint8_t *p, uint16_t len) {
+  uint16_t crc = 0xffff;
+
+  while (len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (byte i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+
+  return crc;
+}
+
+
+int __tz_snapshot_write(tz_snapshot *snap, const tz_rule *rules,
+			const tz_window *window) {
+  memset(snap, 0, sizeof(tz_snapshot));
+
+  snap->magic = TZ_SNAPSHOT_MAGIC;
+  snap->size = sizeof(tz_snapshot);
+  snap->version = TZ_SNAPSHOT_VERSION;
+  memcpy(snap->zone.rules, rules, sizeof(snap->zone.rules));
+  memcpy(&snap->zone.window, window, sizeof(snap->zone.window));
+  snap->crc = __tz_snapshot_crc((const uint8_t*)snap,
+				offsetof(tz_snapshot, crc));
+
+  return 0;
+}
+
+
+int __tz_snapshot_read(const tz_snapshot *snap, tz_rule *rules,
+		       tz_window *window) {
+  if (snap->magic != TZ_SNAPSHOT_MAGIC) return -1;
+  if (snap->version != TZ_SNAPSHOT_VERSION) return -2;
+  if (snap->size != sizeof(tz_snapshot)) return -3;
+  if (snap->zone.window.count > TZ_WINDOW_SIZE) return -4;
+  if (snap->crc != __tz_snapshot_crc((const uint8_t*)snap,
+				     offsetof(tz_snapshot, crc)))
+    return -5;
+
+  memcpy(rules, snap->zone.rules, sizeof(snap->zone.rules));
+  memcpy(window, &snap->zone.window, sizeof(snap->zone.window));
+
+  return 0;
+}
+
+
+/* eof :-) */
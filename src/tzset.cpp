@@ -42,15 +42,11 @@
   ((year) % 4 == 0 && ((year) % 100 != 0 || (year) % 400 == 0))
 
 
-typedef uint32_t time_t;
-
-
 /* tz_rules[0] is standard, tz_rules[1] is daylight.  */
 //static tz_rule tz_rules[2];
-#define tz_rules TinyTimezone::tz_rules
 
 /* How many days come before each month (0-12).  */
-const unsigned int __mon_yday[2][13] =
+const unsigned short int __mon_yday[2][13] =
   {
     /* Normal years.  */
     { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
@@ -66,13 +62,13 @@ static uint32_t compute_offset (uint32_t ss, uint32_t mm, uint32_t hh)
 }
 
 
-/* Parse the POSIX TZ-style string.  */
-void __tzset_parse_tz (const char *tz)
+/* Parse the POSIX TZ-style string into TZ_RULES[2].  */
+void __tzset_parse_tz (const char *tz, tz_rule *tz_rules)
 {
   unsigned short int hh, mm, ss;
 
   /* Clear out old state and reset to unnamed UTC.  */
-  memset (tz_rules, '\0', sizeof tz_rules);
+  memset (tz_rules, '\0', 2 * sizeof (tz_rule));
   //tz_rules[0].name = tz_rules[1].name = "";
 
   /* Get the standard timezone name.  */
@@ -97,8 +93,7 @@ void __tzset_parse_tz (const char *tz)
   else
     tz += consumed;
 
-  memcpy(tz_rules[0].name, tzbuf, min(consumed,TZ_NAME_MAX_LEN));
-  tz_rules[0].name[min(consumed,TZ_NAME_MAX_LEN)]=0;
+  strncpy(tz_rules[0].name, tzbuf, TZ_NAME_MAX_LEN);
 
   /* Figure out the standard offset from UTC.  */
   if (*tz == '\0' || (*tz != '+' && *tz != '-' && !isdigit (*tz)))
@@ -151,8 +146,7 @@ void __tzset_parse_tz (const char *tz)
 	tz += consumed;
 
       //tz_rules[1].name = __tzstring (tzbuf);
-      memcpy(tz_rules[1].name, tzbuf, min(consumed,TZ_NAME_MAX_LEN));
-      tz_rules[1].name[min(consumed,TZ_NAME_MAX_LEN)]=0;
+      strncpy(tz_rules[1].name, tzbuf, TZ_NAME_MAX_LEN);
 
       /* Figure out the DST offset from GMT.  */
       if (*tz == '-' || *tz == '+')
@@ -304,7 +298,7 @@ void __tzset_parse_tz (const char *tz)
    put it in RULE->change, saving YEAR in RULE->computed_for.  */
 void __tzset_compute_change (tz_rule *rule, int year)
 {
-  register time_t t;
+  register uint32_t t;
 
   if (year != -1 && rule->computed_for == year)
     /* Operations on times in 2 BC will be slower.  Oh well.  */
@@ -387,3 +381,84 @@ void __tzset_compute_change (tz_rule *rule, int year)
 }
 
 
+
+
+/* Precompute times of change for YEARS years starting from YEAR
+   into WINDOW, so that __tzset_window_isdst can answer without
+   calendar math.  Leaves WINDOW empty if there is no DST, or if
+   the rules do not alternate the same way every year.  */
+void __tzset_compute_window (tz_rule *rules, tz_window *window,
+			     int year, uint8_t years)
+{
+  uint8_t i, first, n = 0;
+
+  window->count = 0;
+  if (!tz_has_dst (rules))
+    return;
+  if (years > TZ_WINDOW_SIZE / 2)
+    years = TZ_WINDOW_SIZE / 2;
+
+  for (i = 0; i < years; i++)
+    {
+      __tzset_compute_change (&rules[0], year + i);
+      __tzset_compute_change (&rules[1], year + i);
+
+      /* FIRST is the rule that takes effect first in this year.  */
+      first = rules[0].change > rules[1].change;
+      if (i == 0)
+	window->isdst = (first == 0);
+      else if (window->isdst != (first == 0)
+	       || rules[first].change <= window->change[n - 1])
+	return;
+      if (rules[first].change == rules[!first].change)
+	return;
+
+      window->change[n++] = rules[first].change;
+      window->change[n++] = rules[!first].change;
+    }
+
+  window->count = n;
+}
+
+
+/* Return index of the last change at or before T in WINDOW,
+   or -1 if T is outside of the precomputed window.  */
+static int window_find (const tz_window *window, uint32_t t)
+{
+  uint8_t lo = 0, hi = window->count, mid;
+
+  if (hi < 2 || t < window->change[0] || t >= window->change[hi - 1])
+    return -1;
+
+  hi--;
+  while (hi - lo > 1)
+    {
+      mid = (lo + hi) / 2;
+      if (window->change[mid] <= t)
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  return lo;
+}
+
+
+/* Return DST flag in effect at T (Unix time) according to WINDOW,
+   or -1 if T is outside of the precomputed window.  */
+int __tzset_window_isdst (const tz_window *window, uint32_t t)
+{
+  int i = window_find (window, t);
+
+  return (i < 0 ? -1 : window->isdst ^ (i & 1));
+}
+
+
+/* Return time of the first change after T according to WINDOW,
+   or 0 if T is outside of the precomputed window.  */
+uint32_t __tzset_window_next (const tz_window *window, uint32_t t)
+{
+  int i = window_find (window, t);
+
+  return (i < 0 ? 0 : window->change[i + 1]);
+}